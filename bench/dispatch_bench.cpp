@@ -0,0 +1,83 @@
+// Throughput of `cppshell --server` dispatch versus plain fork+exec `sh -c`.
+//
+//   cppshell --server /tmp/cppshell.sock &
+//   cppshell-bench /tmp/cppshell.sock [COUNT] [CONCURRENCY] [COMMAND]
+#include "rpc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <sys/wait.h>
+
+static int run_sh(const std::string& cmd, int devnull) {
+    pid_t pid = ::fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        ::dup2(devnull, STDOUT_FILENO);
+        ::execl("/bin/sh", "sh", "-c", cmd.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    if (::waitpid(pid, &status, 0) < 0) return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128;
+}
+
+static void report(const char* name, int count, int concurrency,
+                   const std::function<int()>& one) {
+    std::atomic<int> next{0}, failed{0};
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < concurrency; ++w) {
+        workers.emplace_back([&] {
+            while (next.fetch_add(1) < count) {
+                if (one() != 0) ++failed;
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("%-14s %6d runs  %8.3fs  %10.1f runs/s  %d failed\n",
+                name, count, secs, count / secs, failed.load());
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: cppshell-bench SOCKET [COUNT] [CONCURRENCY] [COMMAND]\n");
+        return 2;
+    }
+    const std::string sock = argv[1];
+    const int count = (argc > 2) ? std::atoi(argv[2]) : 2000;
+    const int concurrency = (argc > 3) ? std::atoi(argv[3]) : 8;
+    const std::string cmd = (argc > 4) ? argv[4] : "true";
+
+    int devnull = ::open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (devnull < 0) { std::perror("open(/dev/null)"); return 1; }
+    const int fds[3] = {devnull, devnull, STDERR_FILENO};
+
+    rpc::Request req;
+    req.line = cmd;
+
+    std::printf("command: %s, concurrency %d\n", cmd.c_str(), concurrency);
+    report("sh -c", count, concurrency, [&] { return run_sh(cmd, devnull); });
+    report("cppshell-srv", count, concurrency, [&] {
+        try {
+            return rpc::call(sock, req, fds).exit_code;
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            return -1;
+        }
+    });
+
+    ::close(devnull);
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Thin client for `cppshell --server`: forwards one SCRIPT (like `sh -c`)
+// together with this process's stdio, cwd and -e overrides, and exits with
+// its status. The script is parsed by the server, so quote it once, as a
+// single argument.
+#include "rpc.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits.h>
+#include <unistd.h>
+
+static int usage() {
+    std::cerr << "usage: cppshell-client [-r] [-e KEY=VALUE]... SOCKET SCRIPT\n";
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    rpc::Request req;
+    bool show_rusage = false;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (std::strcmp(argv[i], "-r") == 0) show_rusage = true;
+        else if (std::strcmp(argv[i], "-e") == 0 && i + 1 < argc) req.env.emplace_back(argv[++i]);
+        else return usage();
+    }
+    if (argc - i != 2) return usage();
+
+    const std::string sock = argv[i];
+    req.line = argv[i + 1];
+
+    char cwd[PATH_MAX];
+    if (::getcwd(cwd, sizeof(cwd))) req.cwd = cwd;
+
+    const int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    try {
+        rpc::Reply rep = rpc::call(sock, req, fds);
+        if (show_rusage) {
+            std::fprintf(stderr, "exit %d  user %.3fs  sys %.3fs  maxrss %lldkB\n",
+                         rep.exit_code, static_cast<double>(rep.utime_us) / 1e6,
+                         static_cast<double>(rep.stime_us) / 1e6,
+                         static_cast<long long>(rep.maxrss_kb));
+        }
+        return rep.exit_code;
+    } catch (const std::exception& e) {
+        std::cerr << "cppshell-client: " << e.what() << "\n";
+        return 255;
+    }
+}
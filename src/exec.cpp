@@ -1,11 +1,16 @@
 #include "exec.hpp"
 #include "sys.hpp"
 #include "jobs.hpp"
+#include "spool.hpp"
+#include "vars.hpp"
 
 #include <cerrno>
 #include <csignal>
 #include <cstdio>
 #include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
 #include <unistd.h>
 #include <sys/wait.h>
 
@@ -61,6 +66,16 @@ std::vector<char*> make_argv(const Command& cmd) {
     return argv;
 }
 
+std::string quote_word(const std::string& w) {
+    if (!w.empty() && w.find_first_of(" \t\n'\"\\|&<>") == std::string::npos) return w;
+    std::string out = "'";
+    for (char c : w) {
+        if (c == '\'') out += "'\\''";
+        else out += c;
+    }
+    return out + "'";
+}
+
 void child_reset_signals() {
     ::signal(SIGINT, SIG_DFL);
     ::signal(SIGQUIT, SIG_DFL);
@@ -72,12 +87,69 @@ void child_reset_signals() {
 
 } // namespace
 
-ExecResult execute_pipeline(const Pipeline& pl) {
+std::string to_string(const Pipeline& pl) {
+    std::string out;
+    for (size_t i = 0; i < pl.cmds.size(); ++i) {
+        if (i) out += " | ";
+        const Command& c = pl.cmds[i];
+        for (auto const& a : c.assigns) out += a.name + "=" + quote_word(a.value) + " ";
+        for (size_t k = 0; k < c.argv.size(); ++k) {
+            if (k) out += ' ';
+            out += quote_word(c.argv[k]);
+        }
+        for (auto const& r : c.redirs) {
+            out += (r.kind == Redir::Kind::In) ? " < "
+                 : (r.kind == Redir::Kind::OutTrunc) ? " > " : " >> ";
+            out += quote_word(r.path);
+        }
+    }
+    if (pl.background) out += " &";
+    return out;
+}
+
+LaunchContext capture_launch_context(const Pipeline& pl) {
+    LaunchContext ctx;
+    ctx.cwd_fd = sys::open_cwd();
+    for (auto const& c : pl.cmds) ctx.envs.push_back(vars().envp_with(c.assigns));
+    return ctx;
+}
+
+ExecResult execute_pipeline(const Pipeline& pl, const LaunchContext* queued) {
+    const int queued_job = queued ? queued->job_id : -1;
+
+    // Bare VAR=val: sets shell variables (local unless exported), nothing to exec.
+    // In the background it would run in a subshell, so it has no effect.
+    if (pl.cmds.size() == 1 && pl.cmds[0].argv.empty()) {
+        if (!pl.background) {
+            for (auto const& a : pl.cmds[0].assigns) vars().set(a.name, a.value);
+        }
+        if (queued_job >= 0) jobs().cancel(queued_job);
+        return ExecResult{};
+    }
+    for (auto const& c : pl.cmds) {
+        if (c.argv.empty()) throw std::runtime_error("empty command");
+    }
+
     const int n = static_cast<int>(pl.cmds.size());
     std::vector<Pipe> pipes;
     pipes.reserve((n > 1) ? static_cast<size_t>(n - 1) : 0);
     for (int i = 0; i < n - 1; ++i) pipes.push_back(make_pipe());
 
+    // Background jobs can have their output captured instead of sharing the tty.
+    const bool capture = pl.background && spool().enabled();
+    Pipe out;
+    if (capture) out = make_pipe();
+
+    // Shared snapshot unless a stage has its own VAR=val prefixes.
+    std::vector<std::shared_ptr<const Envp>> envs;
+    if (queued && queued->envs.size() == pl.cmds.size()) {
+        envs = queued->envs;
+    } else {
+        envs.reserve(static_cast<size_t>(n));
+        for (auto const& c : pl.cmds) envs.push_back(vars().envp_with(c.assigns));
+    }
+    const int cwd_fd = queued ? queued->cwd_fd : -1;
+
     pid_t pgid = 0;
     std::vector<pid_t> pids;
     pids.reserve(static_cast<size_t>(n));
@@ -87,23 +159,38 @@ ExecResult execute_pipeline(const Pipeline& pl) {
         if (pid < 0) sys::throw_errno("fork");
 
         if (pid == 0) {
-            child_reset_signals();
-
-            if (pgid == 0) pgid = ::getpid();
-            if (::setpgid(0, pgid) < 0) sys::throw_errno("setpgid(child)");
-
-            if (i > 0) {
-                if (::dup2(pipes[i-1].r.get(), STDIN_FILENO) < 0) sys::throw_errno("dup2(pipe in)");
-            }
-            if (i < n - 1) {
-                if (::dup2(pipes[i].w.get(), STDOUT_FILENO) < 0) sys::throw_errno("dup2(pipe out)");
+            try {
+                child_reset_signals();
+
+                // Before redirections, so relative paths resolve where the job was typed.
+                if (cwd_fd >= 0 && ::fchdir(cwd_fd) < 0) sys::throw_errno("fchdir");
+
+                if (pgid == 0) pgid = ::getpid();
+                if (::setpgid(0, pgid) < 0) sys::throw_errno("setpgid(child)");
+
+                if (i > 0) {
+                    if (::dup2(pipes[i-1].r.get(), STDIN_FILENO) < 0) sys::throw_errno("dup2(pipe in)");
+                }
+                if (i < n - 1) {
+                    if (::dup2(pipes[i].w.get(), STDOUT_FILENO) < 0) sys::throw_errno("dup2(pipe out)");
+                }
+                if (capture) {
+                    if (i == n - 1 && ::dup2(out.w.get(), STDOUT_FILENO) < 0) sys::throw_errno("dup2(spool out)");
+                    if (::dup2(out.w.get(), STDERR_FILENO) < 0) sys::throw_errno("dup2(spool err)");
+                }
+
+                for (auto& p : pipes) { p.r.reset(); p.w.reset(); }
+                out.r.reset(); out.w.reset();
+
+                apply_redirs(pl.cmds[i]);
+            } catch (const std::exception& e) {
+                // Never let a failed child fall back into the caller's loop.
+                std::fprintf(stderr, "%s\n", e.what());
+                _exit(1);
             }
 
-            for (auto& p : pipes) { p.r.reset(); p.w.reset(); }
-
-            apply_redirs(pl.cmds[i]);
-
             auto argv = make_argv(pl.cmds[i]);
+            environ = envs[i]->data();  // execvp searches this PATH and passes it on
             ::execvp(argv[0], argv.data());
             std::fprintf(stderr, "execvp failed: %s\n", std::strerror(errno));
             _exit(127);
@@ -117,14 +204,22 @@ ExecResult execute_pipeline(const Pipeline& pl) {
     }
 
     for (auto& p : pipes) { p.r.reset(); p.w.reset(); }
+    out.w.reset();
 
     ExecResult res;
 
     if (pl.background) {
-        int id = jobs().add_job(pgid, "(background)", pids);
+        int id = queued_job;
+        if (id >= 0) jobs().start_job(id, pgid, pids);
+        else id = jobs().add_job(pgid, to_string(pl), pids);
+        if (capture) {
+            sys::set_nonblock(out.r.get());
+            spool().attach(id, out.r.release());
+        }
         res.started_background = true;
         res.job_id = id;
-        std::printf("[%d] %d\n", id, (int)pgid);
+        // A released queued job was already announced when it was queued.
+        if (queued_job < 0) std::printf("[%d] %d\n", id, (int)pgid);
         return res;
     }
 
@@ -1,14 +1,23 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 
+struct Envp;
+
 struct Redir {
     enum class Kind { In, OutTrunc, OutAppend };
     Kind kind{};
     std::string path;
 };
 
+struct Assign {
+    std::string name;
+    std::string value;
+};
+
 struct Command {
+    std::vector<Assign> assigns;   // VAR=val prefixes, exported to this command only
     std::vector<std::string> argv;
     std::vector<Redir> redirs;
 };
@@ -24,4 +33,20 @@ struct ExecResult {
     int job_id{-1};
 };
 
-ExecResult execute_pipeline(const Pipeline& pl);
+// What a queued background job saw when it was typed: it must start in that
+// directory and environment, not whatever the shell has when it is released.
+struct LaunchContext {
+    int job_id{-1};                                 // Queued entry in the Jobs table
+    int cwd_fd{-1};                                 // O_PATH dirfd; owned by the caller
+    std::vector<std::shared_ptr<const Envp>> envs;  // one per stage
+};
+
+// Snapshots the current cwd and per-stage envp for pl (job_id left unset).
+LaunchContext capture_launch_context(const Pipeline& pl);
+
+// queued: start a job already in the Jobs table (Queued) with its saved
+// context, instead of registering a new one with the current state.
+ExecResult execute_pipeline(const Pipeline& pl, const LaunchContext* queued = nullptr);
+
+// Shell-like rendering, used for job listings.
+std::string to_string(const Pipeline& pl);
@@ -4,19 +4,62 @@ static Jobs g_jobs;
 
 Jobs& jobs() { return g_jobs; }
 
+const char* to_string(JobState s) {
+    switch (s) {
+    case JobState::Queued:  return "Queued";
+    case JobState::Running: return "Running";
+    case JobState::Done:    return "Done";
+    }
+    return "?";
+}
+
 int Jobs::add_job(pid_t pgid, std::string cmdline, std::vector<pid_t> pids) {
     Job j;
     j.id = next_id_++;
     j.pgid = pgid;
     j.cmdline = std::move(cmdline);
-    j.running = true;
+    j.state = JobState::Running;
     for (pid_t p : pids) j.procs.push_back(JobProcess{p});
     jobs_.push_back(std::move(j));
     return jobs_.back().id;
 }
 
-void Jobs::mark_done(pid_t /*pid*/, int /*status*/) {
-    // TODO: Track all child statuses and mark job finished only when all pids exit.
+int Jobs::add_queued(std::string cmdline) {
+    Job j;
+    j.id = next_id_++;
+    j.cmdline = std::move(cmdline);
+    j.state = JobState::Queued;
+    jobs_.push_back(std::move(j));
+    return jobs_.back().id;
+}
+
+void Jobs::start_job(int id, pid_t pgid, std::vector<pid_t> pids) {
+    for (auto& j : jobs_) {
+        if (j.id != id) continue;
+        j.pgid = pgid;
+        j.state = JobState::Running;
+        for (pid_t p : pids) j.procs.push_back(JobProcess{p});
+        return;
+    }
+}
+
+void Jobs::cancel(int id) {
+    for (auto& j : jobs_) if (j.id == id) j.state = JobState::Done;
+}
+
+void Jobs::mark_done(pid_t pid, int status) {
+    for (auto& j : jobs_) {
+        for (auto& p : j.procs) {
+            if (p.pid != pid) continue;
+            p.done = true;
+            p.status = status;
+
+            bool all = true;
+            for (auto const& q : j.procs) all = all && q.done;
+            if (all) j.state = JobState::Done;
+            return;
+        }
+    }
 }
 
 std::optional<Job> Jobs::find_by_id(int id) const {
@@ -31,6 +74,12 @@ std::optional<Job> Jobs::find_by_pgid(pid_t pgid) const {
 
 std::vector<Job> Jobs::list() const { return jobs_; }
 
+int Jobs::count(JobState s) const {
+    int n = 0;
+    for (auto const& j : jobs_) if (j.state == s) ++n;
+    return n;
+}
+
 bool Jobs::set_foreground(int /*id*/) {
     return false;
 }
@@ -4,23 +4,35 @@
 #include <optional>
 #include <sys/types.h>
 
-struct JobProcess { pid_t pid{}; };
+struct JobProcess {
+    pid_t pid{};
+    bool done{false};
+    int status{0};
+};
+
+enum class JobState { Queued, Running, Done };
 
 struct Job {
     int id{};
     pid_t pgid{};
     std::string cmdline;
-    bool running{true};
+    JobState state{JobState::Running};
     std::vector<JobProcess> procs;
 };
 
+const char* to_string(JobState s);
+
 class Jobs {
 public:
     int add_job(pid_t pgid, std::string cmdline, std::vector<pid_t> pids);
+    int add_queued(std::string cmdline);            // waiting for admission
+    void start_job(int id, pid_t pgid, std::vector<pid_t> pids);
+    void cancel(int id);                            // queued job that never started
     void mark_done(pid_t pid, int status);
     std::optional<Job> find_by_id(int id) const;
     std::optional<Job> find_by_pgid(pid_t pgid) const;
     std::vector<Job> list() const;
+    int count(JobState s) const;
 
     bool set_foreground(int id); // skeleton
 
@@ -1,6 +1,15 @@
 #include "shell.hpp"
+#include "server.hpp"
+
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::strcmp(argv[1], "--server") == 0) {
+        if (argc < 3) { std::cerr << "usage: cppshell --server SOCKET\n"; return 2; }
+        return run_server(argv[2]);
+    }
 
-int main() {
     Shell sh;
     return sh.run();
 }
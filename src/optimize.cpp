@@ -0,0 +1,68 @@
+#include "optimize.hpp"
+#include "vars.hpp"
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+static Optimizer g_optimizer;
+
+Optimizer& optimizer() { return g_optimizer; }
+
+// `cat` with no prefix assignments or redirections of its own.
+static bool is_plain_cat(const Command& c) {
+    return !c.argv.empty() && c.argv[0] == "cat" && c.assigns.empty() && c.redirs.empty();
+}
+
+static bool has_input_redir(const Command& c) {
+    for (auto const& r : c.redirs) if (r.kind == Redir::Kind::In) return true;
+    return false;
+}
+
+// Only then does `< FILE` behave like `cat FILE`: a missing or unreadable
+// file would fail the redirect and skip the next stage instead of cat alone.
+static bool is_readable_file(const std::string& path) {
+    struct stat st{};
+    return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+           ::access(path.c_str(), R_OK) == 0;
+}
+
+bool Optimizer::enabled() const {
+    return level_ != Level::Off && !vars().get("POSIXLY_CORRECT");
+}
+
+Pipeline Optimizer::run(const Pipeline& pl, std::vector<std::string>* notes) const {
+    Pipeline out = pl;
+    auto note = [&](std::string s) { if (notes) notes->push_back(std::move(s)); };
+
+    // a | cat | b  ->  a | b: both neighbours see a pipe either way.
+    for (size_t i = 1; i + 1 < out.cmds.size(); ) {
+        const Command& c = out.cmds[i];
+        if (is_plain_cat(c) && c.argv.size() == 1) {
+            out.cmds.erase(out.cmds.begin() + static_cast<std::ptrdiff_t>(i));
+            note("dropped 'cat' between stages");
+        } else {
+            ++i;
+        }
+    }
+
+    // cat FILE | cmd  ->  cmd < FILE
+    if (out.cmds.size() >= 2 && is_plain_cat(out.cmds[0]) && out.cmds[0].argv.size() == 2 &&
+        !out.cmds[0].argv[1].empty() && out.cmds[0].argv[1][0] != '-' &&
+        !has_input_redir(out.cmds[1]) && is_readable_file(out.cmds[0].argv[1])) {
+        std::string file = out.cmds[0].argv[1];
+        out.cmds.erase(out.cmds.begin());
+        out.cmds[0].redirs.insert(out.cmds[0].redirs.begin(), Redir{Redir::Kind::In, file});
+        note("leading 'cat " + file + "' became '< " + file + "'");
+    }
+
+    // cmd | cat  ->  cmd. Changes the exit status, so only at level All.
+    // On a terminal the last stage would see a tty instead of a pipe
+    // (colors, column output), so keep cat there.
+    if (level_ == Level::All && out.cmds.size() >= 2 && is_plain_cat(out.cmds.back()) && out.cmds.back().argv.size() == 1 &&
+        !::isatty(STDOUT_FILENO)) {
+        out.cmds.pop_back();
+        note("dropped trailing 'cat'");
+    }
+
+    return out;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "exec.hpp"
+
+#include <string>
+#include <vector>
+
+// Rewrites pipelines between parse_pipeline and execute_pipeline to save
+// forks and pipe copies. Safe level (default) keeps output and exit status:
+//   cat FILE | cmd ...   ->  cmd ... < FILE      (FILE a readable regular file)
+//   a | cat | b          ->  a | b
+// All level also drops a trailing cat, which makes the pipeline report the
+// previous stage's exit status instead of cat's:
+//   ... | cmd | cat      ->  ... | cmd           (only when stdout is not a tty)
+// POSIXLY_CORRECT turns the pass off whatever the level.
+class Optimizer {
+public:
+    enum class Level { Off, Safe, All };
+
+    bool enabled() const;
+    Level level() const { return level_; }
+    void set_level(Level l) { level_ = l; }
+
+    // Returns the rewritten pipeline; appends one line per rewrite to notes.
+    Pipeline run(const Pipeline& pl, std::vector<std::string>* notes = nullptr) const;
+
+private:
+    Level level_{Level::Safe};
+};
+
+Optimizer& optimizer();
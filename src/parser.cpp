@@ -1,8 +1,18 @@
 #include "parser.hpp"
+#include "vars.hpp"
 #include <stdexcept>
 
 static bool is_word(const Tok& t) { return t.kind == TokKind::Word; }
 
+bool is_assignment(const Tok& t, Assign* out) {
+    // "A=1" or $X expanding to A=1 is a command name, not an assignment.
+    if (!is_word(t) || t.text.find('=') >= t.literal_len) return false;
+    Assign a;
+    if (!split_assignment(t.text, a)) return false;
+    if (out) *out = std::move(a);
+    return true;
+}
+
 Pipeline parse_pipeline(const std::vector<Tok>& toks) {
     Pipeline pl;
     Command cur;
@@ -17,9 +27,13 @@ Pipeline parse_pipeline(const std::vector<Tok>& toks) {
         const Tok& t = toks[i];
 
         switch (t.kind) {
-        case TokKind::Word:
-            cur.argv.push_back(t.text);
+        case TokKind::Word: {
+            // Leading NAME=value words are assignments, not arguments.
+            Assign a;
+            if (cur.argv.empty() && is_assignment(t, &a)) cur.assigns.push_back(std::move(a));
+            else cur.argv.push_back(t.text);
             break;
+        }
 
         case TokKind::Pipe:
             finish_cmd();
@@ -53,7 +67,9 @@ Pipeline parse_pipeline(const std::vector<Tok>& toks) {
         }
     }
 
-    if (!cur.argv.empty()) pl.cmds.push_back(std::move(cur));
+    if (!cur.argv.empty() || !cur.assigns.empty()) pl.cmds.push_back(std::move(cur));
     if (pl.cmds.empty()) throw std::runtime_error("no command");
+    // A bare assignment (no argv) only makes sense on its own.
+    if (pl.cmds.size() > 1 && pl.cmds.back().argv.empty()) throw std::runtime_error("empty command");
     return pl;
 }
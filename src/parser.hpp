@@ -4,3 +4,6 @@
 #include <vector>
 
 Pipeline parse_pipeline(const std::vector<Tok>& toks);
+
+// NAME=value word whose NAME= came from the input verbatim.
+bool is_assignment(const Tok& t, Assign* out = nullptr);
@@ -0,0 +1,256 @@
+#include "rpc.hpp"
+#include "sys.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace rpc {
+
+namespace {
+
+constexpr size_t kReplySize = sizeof(int32_t) + 3 * sizeof(int64_t);
+
+sockaddr_un make_addr(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("socket path too long");
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+void write_all(int fd, const void* data, size_t n) {
+    auto p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            sys::throw_errno("send");
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+}
+
+void read_all(int fd, void* data, size_t n) {
+    auto p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = ::read(fd, p, n);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            sys::throw_errno("read");
+        }
+        if (r == 0) throw std::runtime_error("peer closed connection");
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+}
+
+void put_str(std::string& out, const std::string& s) {
+    uint32_t len = static_cast<uint32_t>(s.size());
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.append(s);
+}
+
+std::string get_str(const std::string& in, size_t& pos) {
+    uint32_t len = 0;
+    if (in.size() - pos < sizeof(len)) throw std::runtime_error("truncated request");
+    std::memcpy(&len, in.data() + pos, sizeof(len));
+    pos += sizeof(len);
+    if (in.size() - pos < len) throw std::runtime_error("truncated request");
+    std::string s = in.substr(pos, len);
+    pos += len;
+    return s;
+}
+
+// Removes path only if it is a socket nobody is listening on any more.
+void remove_stale_socket(const std::string& path) {
+    struct stat st{};
+    if (::lstat(path.c_str(), &st) < 0) {
+        if (errno == ENOENT) return;
+        sys::throw_errno("lstat");
+    }
+
+    bool stale = false;
+    if (S_ISSOCK(st.st_mode)) {
+        sockaddr_un addr = make_addr(path);
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) sys::throw_errno("socket");
+        stale = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 &&
+                errno == ECONNREFUSED;
+        ::close(probe);
+    }
+
+    if (!stale) {
+        errno = EADDRINUSE;
+        sys::throw_errno(path.c_str());
+    }
+    if (::unlink(path.c_str()) < 0) sys::throw_errno("unlink(stale socket)");
+}
+
+} // namespace
+
+int connect_unix(const std::string& path) {
+    sockaddr_un addr = make_addr(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) sys::throw_errno("socket");
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        sys::throw_errno("connect");
+    }
+    return fd;
+}
+
+int listen_unix(const std::string& path) {
+    sockaddr_un addr = make_addr(path);
+    remove_stale_socket(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) sys::throw_errno("socket");
+    // Anyone who can connect can run commands as us: owner-only from the start.
+    mode_t old_mask = ::umask(0077);
+    int rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (rc < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        sys::throw_errno("bind/listen");
+    }
+    return fd;
+}
+
+uid_t peer_uid(int sock) {
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) sys::throw_errno("SO_PEERCRED");
+    return cred.uid;
+}
+
+void send_request(int sock, const Request& req, const int fds[3]) {
+    std::string payload;
+    uint32_t count = static_cast<uint32_t>(2 + req.env.size());
+    payload.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    put_str(payload, req.cwd);
+    put_str(payload, req.line);
+    for (auto const& e : req.env) put_str(payload, e);
+
+    if (payload.size() > kMaxRequestBytes) throw std::runtime_error("request too large");
+
+    // The length header carries the three stdio fds.
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    iovec iov{&len, sizeof(len)};
+    alignas(cmsghdr) char ctl[CMSG_SPACE(3 * sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl;
+    msg.msg_controllen = sizeof(ctl);
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(3 * sizeof(int));
+    std::memcpy(CMSG_DATA(c), fds, 3 * sizeof(int));
+
+    ssize_t w;
+    do { w = ::sendmsg(sock, &msg, MSG_NOSIGNAL); } while (w < 0 && errno == EINTR);
+    if (w < 0) sys::throw_errno("sendmsg");
+    if (static_cast<size_t>(w) < sizeof(len)) {
+        write_all(sock, reinterpret_cast<const char*>(&len) + w, sizeof(len) - static_cast<size_t>(w));
+    }
+    write_all(sock, payload.data(), payload.size());
+}
+
+Request recv_request(int sock, int fds[3]) {
+    uint32_t len = 0;
+    iovec iov{&len, sizeof(len)};
+    alignas(cmsghdr) char ctl[CMSG_SPACE(3 * sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl;
+    msg.msg_controllen = sizeof(ctl);
+
+    ssize_t r;
+    do { r = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC); } while (r < 0 && errno == EINTR);
+    if (r < 0) sys::throw_errno("recvmsg");
+    if (r == 0) throw std::runtime_error("peer closed connection");
+
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_type != SCM_RIGHTS || c->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+        throw std::runtime_error("request without stdio fds");
+    std::memcpy(fds, CMSG_DATA(c), 3 * sizeof(int));
+
+    if (static_cast<size_t>(r) < sizeof(len)) {
+        read_all(sock, reinterpret_cast<char*>(&len) + r, sizeof(len) - static_cast<size_t>(r));
+    }
+
+    // Peer-controlled: bound it before allocating.
+    if (len > kMaxRequestBytes) throw std::runtime_error("request too large");
+
+    std::string payload(len, '\0');
+    read_all(sock, payload.data(), payload.size());
+
+    size_t pos = 0;
+    uint32_t count = 0;
+    if (payload.size() < sizeof(count)) throw std::runtime_error("truncated request");
+    std::memcpy(&count, payload.data(), sizeof(count));
+    pos += sizeof(count);
+    // Every field needs at least its length prefix.
+    if (count < 2 || count > (payload.size() - pos) / sizeof(uint32_t))
+        throw std::runtime_error("malformed request");
+
+    Request req;
+    req.cwd = get_str(payload, pos);
+    req.line = get_str(payload, pos);
+    req.env.reserve(count - 2);
+    for (uint32_t i = 2; i < count; ++i) req.env.push_back(get_str(payload, pos));
+    if (pos != payload.size()) throw std::runtime_error("malformed request");
+    return req;
+}
+
+// Client and server always share a host, so fields go out in native byte
+// order; they are packed one by one so struct padding never hits the wire.
+void send_reply(int sock, const Reply& rep) {
+    char buf[kReplySize];
+    char* p = buf;
+    auto put = [&](const auto& v) { std::memcpy(p, &v, sizeof(v)); p += sizeof(v); };
+    put(rep.exit_code);
+    put(rep.utime_us);
+    put(rep.stime_us);
+    put(rep.maxrss_kb);
+    write_all(sock, buf, sizeof(buf));
+}
+
+Reply recv_reply(int sock) {
+    char buf[kReplySize];
+    read_all(sock, buf, sizeof(buf));
+    const char* p = buf;
+    auto get = [&](auto& v) { std::memcpy(&v, p, sizeof(v)); p += sizeof(v); };
+    Reply rep;
+    get(rep.exit_code);
+    get(rep.utime_us);
+    get(rep.stime_us);
+    get(rep.maxrss_kb);
+    return rep;
+}
+
+Reply call(const std::string& path, const Request& req, const int fds[3]) {
+    int sock = connect_unix(path);
+    try {
+        send_request(sock, req, fds);
+        Reply rep = recv_reply(sock);
+        ::close(sock);
+        return rep;
+    } catch (...) {
+        ::close(sock);
+        throw;
+    }
+}
+
+} // namespace rpc
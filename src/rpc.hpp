@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Wire format shared by `cppshell --server` and its clients.
+// A request is a u32 payload length (carrying stdin/stdout/stderr via
+// SCM_RIGHTS) followed by length-prefixed strings: cwd, command line, env.
+namespace rpc {
+
+// Upper bound on a request payload, checked before allocating; generous
+// next to the kernel's default 2 MiB ARG_MAX for argv + envp.
+constexpr uint32_t kMaxRequestBytes = 4u << 20;
+
+struct Request {
+    std::string cwd;                 // empty = inherit the server's cwd
+    std::string line;                // parsed with tokenize/parse_pipeline
+    std::vector<std::string> env;    // KEY=VALUE overrides
+};
+
+struct Reply {
+    int32_t exit_code{0};
+    int64_t utime_us{0};
+    int64_t stime_us{0};
+    int64_t maxrss_kb{0};
+};
+
+int  connect_unix(const std::string& path);
+int  listen_unix(const std::string& path);   // socket is created mode 0600
+uid_t peer_uid(int sock);                     // SO_PEERCRED of a connected socket
+
+void send_request(int sock, const Request& req, const int fds[3]);
+Request recv_request(int sock, int fds[3]);
+
+void send_reply(int sock, const Reply& rep);
+Reply recv_reply(int sock);
+
+// Connects, sends one request and waits for its reply.
+Reply call(const std::string& path, const Request& req, const int fds[3]);
+
+} // namespace rpc
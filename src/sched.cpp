@@ -0,0 +1,105 @@
+#include "sched.hpp"
+#include "jobs.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+static Scheduler g_scheduler;
+
+Scheduler& scheduler() { return g_scheduler; }
+
+std::optional<double> read_psi_avg10(const char* path) {
+    // Format: "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345"
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line); ) {
+        if (line.rfind("some ", 0) != 0) continue;
+        auto pos = line.find("avg10=");
+        if (pos == std::string::npos) return std::nullopt;
+        return std::strtod(line.c_str() + pos + 6, nullptr);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Scheduler::blocked_reason() const {
+    const int running = jobs().count(JobState::Running);
+    if (limits_.max_running > 0 && running >= limits_.max_running)
+        return "running " + std::to_string(running) + "/" + std::to_string(limits_.max_running);
+
+    // Pressure gates only throttle; with nothing running the queue always moves.
+    if (running == 0) return std::nullopt;
+
+    std::ostringstream why;
+    if (limits_.cpu_psi > 0) {
+        auto v = read_psi_avg10("/proc/pressure/cpu");
+        if (v && *v > limits_.cpu_psi) { why << "cpu pressure " << *v << "%"; return why.str(); }
+    }
+    if (limits_.mem_psi > 0) {
+        auto v = read_psi_avg10("/proc/pressure/memory");
+        if (v && *v > limits_.mem_psi) { why << "memory pressure " << *v << "%"; return why.str(); }
+    }
+    if (limits_.load > 0) {
+        double avg[1];
+        if (::getloadavg(avg, 1) == 1 && avg[0] > limits_.load) {
+            why << "load " << avg[0];
+            return why.str();
+        }
+    }
+    return std::nullopt;
+}
+
+bool Scheduler::trickle() const {
+    return limits_.max_running == 0 &&
+           (limits_.cpu_psi > 0 || limits_.mem_psi > 0 || limits_.load > 0);
+}
+
+bool Scheduler::sample_due(std::chrono::steady_clock::time_point now) const {
+    // PSI avg10 is refreshed every 2s; don't release faster than it can react.
+    return !trickle() || now - last_release_ >= std::chrono::seconds(2);
+}
+
+ExecResult Scheduler::submit(const Pipeline& pl) {
+    // FIFO: nothing jumps ahead of jobs already waiting.
+    const auto now = std::chrono::steady_clock::now();
+    if (queue_.empty() && sample_due(now) && !blocked_reason()) {
+        last_release_ = now;
+        return execute_pipeline(pl);
+    }
+
+    // Freeze cwd and environment now; the job may start much later.
+    LaunchContext ctx = capture_launch_context(pl);
+
+    ExecResult res;
+    res.job_id = jobs().add_queued(to_string(pl));
+    res.started_background = true;
+    ctx.job_id = res.job_id;
+    queue_.push_back(Queued{pl, std::move(ctx)});
+    std::printf("[%d] queued\n", res.job_id);
+    return res;
+}
+
+int Scheduler::pump() {
+    const auto now = std::chrono::steady_clock::now();
+    if (!sample_due(now)) return 0;
+
+    int started = 0;
+    while (!queue_.empty() && !blocked_reason()) {
+        Queued q = std::move(queue_.front());
+        queue_.pop_front();
+        try {
+            execute_pipeline(q.pl, &q.ctx);
+            ++started;
+        } catch (const std::exception& e) {
+            std::cerr << "error: job " << q.ctx.job_id << ": " << e.what() << "\n";
+            jobs().cancel(q.ctx.job_id);
+        }
+        ::close(q.ctx.cwd_fd);
+        last_release_ = now;
+        if (trickle()) break;
+    }
+    return started;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "exec.hpp"
+
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string>
+
+// Admission limits for background jobs. Zero disables a limit.
+struct SchedLimits {
+    int max_running{0};     // concurrently running background jobs
+    double cpu_psi{0};      // /proc/pressure/cpu "some avg10" threshold (%)
+    double mem_psi{0};      // /proc/pressure/memory "some avg10" threshold (%)
+    double load{0};         // 1-minute load average threshold
+};
+
+// Sits in front of background job launch: jobs that cannot be admitted are
+// parked as Queued in the Jobs table and started by pump() as slots free up.
+class Scheduler {
+public:
+    // Starts pl now or queues it; pl must be a background pipeline.
+    ExecResult submit(const Pipeline& pl);
+
+    // Launches queued jobs while admission allows. Returns how many started.
+    // Pressure readings lag behind launches, so when only PSI/load gates
+    // apply (no max_running), submit() and pump() together start at most
+    // one job per pressure sample.
+    int pump();
+
+    SchedLimits& limits() { return limits_; }
+    const SchedLimits& limits() const { return limits_; }
+
+    // Why the next job would be held back, or nullopt if it can start now.
+    std::optional<std::string> blocked_reason() const;
+
+private:
+    bool trickle() const;   // only pressure/load gates are set
+    bool sample_due(std::chrono::steady_clock::time_point now) const;
+
+    struct Queued {
+        Pipeline pl;
+        LaunchContext ctx;   // owns ctx.cwd_fd
+    };
+
+    SchedLimits limits_;
+    std::deque<Queued> queue_;
+    std::chrono::steady_clock::time_point last_release_{};
+};
+
+// "some avg10" from a PSI file, or nullopt where PSI is unavailable.
+std::optional<double> read_psi_avg10(const char* path);
+
+Scheduler& scheduler();
@@ -0,0 +1,115 @@
+#include "server.hpp"
+#include "rpc.hpp"
+#include "sys.hpp"
+#include "tokenizer.hpp"
+#include "parser.hpp"
+#include "exec.hpp"
+#include "vars.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace {
+
+int64_t to_us(const timeval& tv) {
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+// Runs in the forked handler; never returns.
+[[noreturn]] void handle_request(int conn) {
+    ::signal(SIGCHLD, SIG_DFL); // execute_pipeline waits on its own children
+    const pid_t handler = ::getpid();
+
+    rpc::Reply rep;
+    try {
+        int fds[3];
+        rpc::Request req = rpc::recv_request(conn, fds);
+
+        for (int i = 0; i < 3; ++i) {
+            if (fds[i] == i) continue;
+            if (::dup2(fds[i], i) < 0) sys::throw_errno("dup2(stdio)");
+            ::close(fds[i]);
+        }
+        if (!req.cwd.empty() && ::chdir(req.cwd.c_str()) < 0) sys::throw_errno("chdir");
+        for (auto const& kv : req.env) {
+            Assign a;
+            if (split_assignment(kv, a)) vars().set_exported(a.name, std::move(a.value));
+        }
+
+        auto tokens = tokenize(req.line);
+        auto pipeline = parse_pipeline(tokens);
+        rep.exit_code = execute_pipeline(pipeline).exit_code;
+    } catch (const std::exception& e) {
+        // A pipeline child that failed before exec must not answer the client.
+        if (::getpid() != handler) _exit(127);
+        std::cerr << "error: " << e.what() << "\n";
+        rep.exit_code = 2;
+    }
+
+    rusage ru{};
+    ::getrusage(RUSAGE_CHILDREN, &ru);
+    rep.utime_us = to_us(ru.ru_utime);
+    rep.stime_us = to_us(ru.ru_stime);
+    rep.maxrss_kb = ru.ru_maxrss;
+
+    std::fflush(nullptr);
+    try { rpc::send_reply(conn, rep); } catch (const std::exception&) {}
+    _exit(0);
+}
+
+} // namespace
+
+int run_server(const std::string& socket_path) {
+    // Handlers are reaped by the kernel; requests run concurrently.
+    struct sigaction sa{};
+    sa.sa_handler = SIG_IGN;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_NOCLDWAIT;
+    sigaction(SIGCHLD, &sa, nullptr);
+
+    int lfd = -1;
+    try {
+        lfd = rpc::listen_unix(socket_path);
+    } catch (const std::exception& e) {
+        std::cerr << "server: " << e.what() << "\n";
+        return 1;
+    }
+    std::cerr << "[server] listening on " << socket_path << "\n";
+
+    while (true) {
+        int conn = ::accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::perror("accept");
+            break;
+        }
+
+        // The socket is 0600, but don't rely on the path's permissions alone.
+        uid_t uid = static_cast<uid_t>(-1);
+        try { uid = rpc::peer_uid(conn); } catch (const std::exception&) {}
+        if (uid != ::geteuid()) {
+            std::cerr << "[server] rejected connection from uid " << static_cast<long>(uid) << "\n";
+            ::close(conn);
+            continue;
+        }
+
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(lfd);
+            handle_request(conn);
+        }
+        if (pid < 0) std::perror("fork");
+        ::close(conn);
+    }
+
+    ::close(lfd);
+    ::unlink(socket_path.c_str());
+    return 1;
+}
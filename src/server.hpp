@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Resident mode: accept command requests on a Unix socket and run each one
+// through tokenize/parse_pipeline/execute_pipeline in a forked handler.
+// Saves the per-command shell startup of `sh -c`. Only returns on error.
+int run_server(const std::string& socket_path);
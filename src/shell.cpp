@@ -3,15 +3,21 @@
 #include "parser.hpp"
 #include "exec.hpp"
 #include "jobs.hpp"
+#include "spool.hpp"
+#include "vars.hpp"
+#include "optimize.hpp"
+#include "sched.hpp"
 
 #include <iostream>
-#include <sstream>
 #include <vector>
 #include <csignal>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <poll.h>
 #include <limits.h>
 #include <cstdlib>
+#include <cmath>
+#include <cerrno>
 
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -20,8 +26,14 @@
 #include <libgen.h>
 
 static volatile sig_atomic_t g_sigchld = 0;
+static volatile sig_atomic_t g_interrupted = 0;
 
 static void on_sigchld(int) { g_sigchld = 1; }
+static void on_sigint(int) { g_interrupted = 1; }
+static int on_readline_idle();
+static void reap_children();
+static void print_spool(int id, bool follow);
+static void explain(const std::vector<Tok>& toks);
 static void print_welcome();
 static std::string history_file_path();
 
@@ -55,6 +67,11 @@ std::string Shell::prompt() const {
 }
 
 void Shell::reap_background() {
+    reap_children();
+    scheduler().pump();
+}
+
+static void reap_children() {
     if (!g_sigchld) return;
     g_sigchld = 0;
 
@@ -66,16 +83,43 @@ void Shell::reap_background() {
     }
 }
 
-static std::vector<std::string> split_ws(const std::string& s) {
-    std::istringstream iss(s);
-    std::vector<std::string> out;
-    for (std::string w; iss >> w; ) out.push_back(w);
-    return out;
+// Accepts "%3" or "3".
+static int parse_job_spec(const std::string& s) {
+    const char* p = s.c_str();
+    if (*p == '%') ++p;
+    char* end = nullptr;
+    long id = std::strtol(p, &end, 10);
+    if (end == p || *end != '\0' || id <= 0) return -1;
+    return static_cast<int>(id);
+}
+
+static bool parse_size(const std::string& s, size_t& out) {
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    if (*end == 'k' || *end == 'K') { v <<= 10; ++end; }
+    else if (*end == 'm' || *end == 'M') { v <<= 20; ++end; }
+    if (*end != '\0') return false;
+    out = static_cast<size_t>(v);
+    return true;
 }
 
-bool Shell::handle_builtin(const std::string& line) {
-    auto parts = split_ws(line);
-    if (parts.empty()) return true;
+bool Shell::handle_builtin(const std::vector<Tok>& toks) {
+    if (toks.empty()) return true;
+
+    // explain takes a whole pipeline, operators included.
+    if (toks[0].kind == TokKind::Word && toks[0].text == "explain") {
+        explain(std::vector<Tok>(toks.begin() + 1, toks.end()));
+        return true;
+    }
+
+    // Builtins run standalone: anything with operators goes to the executor.
+    std::vector<std::string> parts;
+    for (auto const& t : toks) {
+        if (t.kind != TokKind::Word) return false;
+        parts.push_back(t.text);
+    }
+    if (is_assignment(toks[0])) return false;
 
     const auto& cmd = parts[0];
 
@@ -91,32 +135,148 @@ bool Shell::handle_builtin(const std::string& line) {
     }
 
     if (cmd == "cd") {
-        const char* path = (parts.size() >= 2) ? parts[1].c_str() : std::getenv("HOME");
-        if (!path) path = "/";
-        if (::chdir(path) < 0) std::perror("cd");
+        std::string path = (parts.size() >= 2) ? parts[1] : vars().get("HOME").value_or("/");
+        if (::chdir(path.c_str()) < 0) std::perror("cd");
         return true;
     }
 
     if (cmd == "export") {
-        // export KEY=VALUE
-        if (parts.size() < 2) { std::cerr << "usage: export KEY=VALUE\n"; return true; }
-        auto pos = parts[1].find('=');
-        if (pos == std::string::npos) { std::cerr << "export expects KEY=VALUE\n"; return true; }
-        std::string k = parts[1].substr(0, pos);
-        std::string v = parts[1].substr(pos + 1);
-        if (::setenv(k.c_str(), v.c_str(), 1) < 0) std::perror("setenv");
+        // export [KEY=VALUE | KEY]...; no arguments lists exported variables
+        if (parts.size() < 2) {
+            for (auto const& k : vars().exported_names())
+                std::cout << "export " << k << "=" << vars().get(k).value_or("") << "\n";
+            return true;
+        }
+        for (size_t i = 1; i < parts.size(); ++i) {
+            Assign a;
+            if (split_assignment(parts[i], a)) vars().set_exported(a.name, std::move(a.value));
+            else if (!is_valid_name(parts[i])) std::cerr << "export: bad name: " << parts[i] << "\n";
+            else if (!vars().export_var(parts[i])) vars().set_exported(parts[i], "");
+        }
         return true;
     }
 
     if (cmd == "unset") {
         if (parts.size() < 2) { std::cerr << "usage: unset KEY\n"; return true; }
-        if (::unsetenv(parts[1].c_str()) < 0) std::perror("unsetenv");
+        for (size_t i = 1; i < parts.size(); ++i) vars().unset(parts[i]);
+        return true;
+    }
+
+    if (cmd == "jobs" && parts.size() >= 2 && parts[1] == "-o") {
+        int id = (parts.size() >= 3) ? parse_job_spec(parts[2]) : -1;
+        if (id < 0) { std::cerr << "usage: jobs -o %n\n"; return true; }
+        print_spool(id, false);
         return true;
     }
 
     if (cmd == "jobs") {
+        // jobs [-q]: -q lists only jobs waiting for admission
+        bool queued_only = parts.size() >= 2 && parts[1] == "-q";
         for (auto const& j : jobs().list()) {
-            std::cout << "[" << j.id << "] " << (int)j.pgid << "  " << j.cmdline << "\n";
+            if (queued_only && j.state != JobState::Queued) continue;
+            std::cout << "[" << j.id << "] ";
+            if (j.state == JobState::Queued) std::cout << "-";
+            else std::cout << (int)j.pgid;
+            std::cout << "  " << to_string(j.state) << "  " << j.cmdline << "\n";
+        }
+        if (queued_only) {
+            if (auto why = scheduler().blocked_reason()) std::cout << "held: " << *why << "\n";
+        }
+        return true;
+    }
+
+    if (cmd == "bgsched") {
+        // bgsched [off | max N | cpu PCT | mem PCT | load N]
+        auto& lim = scheduler().limits();
+        if (parts.size() == 1) {
+            auto cpu = read_psi_avg10("/proc/pressure/cpu");
+            auto mem = read_psi_avg10("/proc/pressure/memory");
+            std::cout << "max " << lim.max_running
+                      << "  cpu " << lim.cpu_psi << "% (now " << (cpu ? std::to_string(*cpu) : "n/a") << ")"
+                      << "  mem " << lim.mem_psi << "% (now " << (mem ? std::to_string(*mem) : "n/a") << ")"
+                      << "  load " << lim.load << "\n";
+            return true;
+        }
+        if (parts[1] == "off") {
+            lim = SchedLimits{};
+        } else if (parts.size() == 3 && parts[1] == "max") {
+            char* end = nullptr;
+            errno = 0;
+            long n = std::strtol(parts[2].c_str(), &end, 10);
+            if (end == parts[2].c_str() || *end != '\0' || errno == ERANGE || n < 0 || n > INT_MAX) {
+                std::cerr << "bgsched: max must be an integer from 0 to " << INT_MAX << "\n";
+                return true;
+            }
+            lim.max_running = static_cast<int>(n);
+        } else if (parts.size() == 3) {
+            char* end = nullptr;
+            double v = std::strtod(parts[2].c_str(), &end);
+            if (end == parts[2].c_str() || *end != '\0' || !std::isfinite(v) || v < 0) {
+                std::cerr << "bgsched: bad value\n";
+                return true;
+            }
+            if (parts[1] == "cpu") lim.cpu_psi = v;
+            else if (parts[1] == "mem") lim.mem_psi = v;
+            else if (parts[1] == "load") lim.load = v;
+            else { std::cerr << "usage: bgsched [off | max N | cpu PCT | mem PCT | load N]\n"; return true; }
+        } else {
+            std::cerr << "usage: bgsched [off | max N | cpu PCT | mem PCT | load N]\n";
+            return true;
+        }
+        scheduler().pump();
+        return true;
+    }
+
+    if (cmd == "output") {
+        // output [-f] %n
+        bool follow = parts.size() >= 2 && parts[1] == "-f";
+        size_t at = follow ? 2 : 1;
+        int id = (parts.size() > at) ? parse_job_spec(parts[at]) : -1;
+        if (id < 0) { std::cerr << "usage: output [-f] %n\n"; return true; }
+        print_spool(id, follow);
+        return true;
+    }
+
+    if (cmd == "spool") {
+        // spool [on|off] | spool cap JOB_BYTES [TOTAL_BYTES]
+        auto& sp = spool();
+        if (parts.size() == 1) {
+            std::cout << "spool " << (sp.enabled() ? "on" : "off")
+                      << ", job cap " << sp.job_cap()
+                      << ", total cap " << sp.total_cap()
+                      << ", in use " << sp.total() << "\n";
+        } else if (parts[1] == "on" || parts[1] == "off") {
+            sp.set_enabled(parts[1] == "on");
+        } else if (parts[1] == "cap" && parts.size() >= 3) {
+            size_t job_cap = 0, total_cap = sp.total_cap();
+            if (!parse_size(parts[2], job_cap) ||
+                (parts.size() >= 4 && !parse_size(parts[3], total_cap))) {
+                std::cerr << "spool: bad size\n";
+                return true;
+            }
+            sp.set_caps(job_cap, total_cap);
+        } else {
+            std::cerr << "usage: spool [on|off] | spool cap JOB_BYTES [TOTAL_BYTES]\n";
+        }
+        return true;
+    }
+
+    if (cmd == "optimize") {
+        // optimize [off|on|all]: on = rewrites that keep output and exit status
+        auto& opt = optimizer();
+        if (parts.size() == 1) {
+            const char* lvl = opt.level() == Optimizer::Level::Off ? "off"
+                            : opt.level() == Optimizer::Level::Safe ? "on" : "all";
+            std::cout << "optimize " << lvl
+                      << (vars().get("POSIXLY_CORRECT") ? " (disabled: POSIXLY_CORRECT set)" : "") << "\n";
+        } else if (parts[1] == "off") {
+            opt.set_level(Optimizer::Level::Off);
+        } else if (parts[1] == "on") {
+            opt.set_level(Optimizer::Level::Safe);
+        } else if (parts[1] == "all") {
+            opt.set_level(Optimizer::Level::All);
+        } else {
+            std::cerr << "usage: optimize [off|on|all]\n";
         }
         return true;
     }
@@ -125,6 +285,60 @@ bool Shell::handle_builtin(const std::string& line) {
     return false;
 }
 
+static int on_readline_idle() {
+    // Called by readline roughly every 100ms while waiting for input.
+    spool().drain();
+    reap_children();
+    scheduler().pump();
+    return 0;
+}
+
+static void print_spool(int id, bool follow) {
+    spool().drain_job(id);
+    const JobSpool* s = spool().find(id);
+    if (!s) { std::cerr << "output: no captured output for job " << id << "\n"; return; }
+
+    if (s->dropped) std::cout << "[... " << s->dropped << " bytes dropped ...]\n";
+    std::cout << s->buf.str() << std::flush;
+    if (!follow || s->fd < 0) return;
+    const int fd = s->fd;  // open spools are never erased, so fd stays valid
+
+    // Stream until the job closes its output or the user hits Ctrl-C.
+    struct sigaction sa{}, old{};
+    sa.sa_handler = on_sigint;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old);
+    g_interrupted = 0;
+
+    std::string fresh;
+    while (!g_interrupted) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (::poll(&pfd, 1, -1) < 0 && errno != EINTR) break;
+        fresh.clear();
+        bool open = spool().drain_job(id, &fresh);
+        std::cout << fresh << std::flush;
+        if (!open) break;
+    }
+
+    sigaction(SIGINT, &old, nullptr);
+}
+
+static void explain(const std::vector<Tok>& toks) {
+    if (toks.empty()) { std::cerr << "usage: explain PIPELINE\n"; return; }
+
+    Pipeline pl = parse_pipeline(toks);
+    std::vector<std::string> notes;
+    Pipeline opt = optimizer().run(pl, &notes);
+
+    std::cout << "original:  " << to_string(pl) << "\n";
+    if (!optimizer().enabled()) {
+        std::cout << "optimized: (optimizer off, runs as original)\n";
+        return;
+    }
+    std::cout << "optimized: " << to_string(opt) << "\n";
+    for (auto const& n : notes) std::cout << "  - " << n << "\n";
+}
+
 static void print_welcome() {
     constexpr const char* BLUE   = "\033[1;34m";
     constexpr const char* GREEN  = "\033[1;32m";
@@ -188,6 +402,10 @@ int Shell::run() {
     // Enable TAB completion via readline
     rl_attempted_completion_function = completion;
 
+    // Keep background job spools drained while idle at the prompt.
+    // Only on a tty: with piped input readline would poll the hook forever at EOF.
+    if (::isatty(STDIN_FILENO)) rl_event_hook = on_readline_idle;
+
     // Initialize readline history subsystem
     using_history();
 
@@ -199,6 +417,7 @@ int Shell::run() {
     print_welcome();
 
     while (true) {
+        if (!rl_event_hook) spool().drain();
         reap_background();
 
         // Read input using readline (REQUIRED for TAB support)
@@ -223,14 +442,16 @@ int Shell::run() {
         append_history(1, hist_file.c_str());
 
         try {
-            // Quick builtin path (simple whitespace split only).
+            // Tokenize (expands $VAR) → builtin or parse → execute
             // NOTE: builtins inside pipelines will be a later milestone.
-            if (handle_builtin(line)) continue;
-
-            // Tokenize → parse → execute
             auto tokens  = tokenize(line);
+            if (handle_builtin(tokens)) continue;
+
             auto pipeline = parse_pipeline(tokens);
-            execute_pipeline(pipeline);
+            if (optimizer().enabled()) pipeline = optimizer().run(pipeline);
+
+            if (pipeline.background) scheduler().submit(pipeline);
+            else vars().set_last_status(execute_pipeline(pipeline).exit_code);
 
         } catch (const std::exception& e) {
             std::cerr << "error: " << e.what() << "\n";
@@ -263,7 +484,8 @@ static char* command_generator(const char* text, int state) {
 
         // Built-in commands
         const char* builtins[] = {
-            "cd", "exit", "pwd", "export", "unset", "jobs"
+            "cd", "exit", "pwd", "export", "unset", "jobs", "output", "spool", "bgsched",
+            "explain", "optimize"
         };
 
         for (auto b : builtins) {
@@ -272,9 +494,8 @@ static char* command_generator(const char* text, int state) {
         }
 
         // PATH executables
-        const char* path = std::getenv("PATH");
-        if (path) {
-            std::string p(path);
+        if (auto path = vars().get("PATH")) {
+            std::string p = *path;
             size_t pos = 0;
 
             while ((pos = p.find(':')) != std::string::npos) {
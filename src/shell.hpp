@@ -1,5 +1,7 @@
 #pragma once
+#include "tokenizer.hpp"
 #include <string>
+#include <vector>
 
 class Shell {
 public:
@@ -10,7 +12,7 @@ private:
     void reap_background();
 
     // Returns true if builtin handled (or empty line). False if not a builtin.
-    bool handle_builtin(const std::string& line);
+    bool handle_builtin(const std::vector<Tok>& toks);
 
     std::string prompt() const;
 };
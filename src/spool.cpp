@@ -0,0 +1,156 @@
+#include "spool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+static Spool g_spool;
+
+Spool& spool() { return g_spool; }
+
+size_t RingBuffer::append(const char* data, size_t n) {
+    if (n == 0) return 0;
+    if (cap_ == 0) return n;
+
+    size_t dropped = 0;
+    if (n >= cap_) {
+        // Only the tail of this chunk survives.
+        dropped = size_ + (n - cap_);
+        data += n - cap_;
+        n = cap_;
+        head_ = 0;
+        size_ = 0;
+    }
+
+    const size_t need = size_ + n;
+    if (need > buf_.size() && buf_.size() < cap_) {
+        grow(std::min(cap_, std::max(need, buf_.size() * 2)));
+    }
+    if (need > cap_) dropped += pop_front(need - cap_);
+
+    size_t tail = (head_ + size_) % buf_.size();
+    size_t first = std::min(n, buf_.size() - tail);
+    std::memcpy(buf_.data() + tail, data, first);
+    std::memcpy(buf_.data(), data + first, n - first);
+    size_ += n;
+    return dropped;
+}
+
+size_t RingBuffer::pop_front(size_t n) {
+    n = std::min(n, size_);
+    if (n == 0) return 0;
+    head_ = (head_ + n) % buf_.size();
+    size_ -= n;
+    return n;
+}
+
+size_t RingBuffer::shrink_to(size_t max_bytes) {
+    size_t dropped = (size_ > max_bytes) ? pop_front(size_ - max_bytes) : 0;
+    if (buf_.size() == size_) return dropped;
+
+    // Reallocate to exactly what is kept; grow() linearizes.
+    if (size_ == 0) {
+        std::vector<char>().swap(buf_);
+        head_ = 0;
+    } else {
+        grow(size_);
+    }
+    return dropped;
+}
+
+std::string RingBuffer::str() const {
+    std::string out;
+    out.reserve(size_);
+    size_t first = std::min(size_, buf_.size() - head_);
+    out.append(buf_.data() + head_, first);
+    out.append(buf_.data(), size_ - first);
+    return out;
+}
+
+void RingBuffer::grow(size_t want) {
+    // Linearize while growing; keeps the wrap logic in append() simple.
+    std::vector<char> next(want);
+    std::string cur = str();
+    std::memcpy(next.data(), cur.data(), cur.size());
+    buf_.swap(next);
+    head_ = 0;
+}
+
+Spool::~Spool() {
+    for (auto& [id, s] : spools_) if (s.fd >= 0) ::close(s.fd);
+}
+
+void Spool::set_caps(size_t job_cap, size_t total_cap) {
+    // Per-job cap applies to jobs started from now on; the total is enforced at once.
+    job_cap_ = job_cap;
+    total_cap_ = total_cap;
+    enforce_total_cap();
+}
+
+size_t Spool::total() const {
+    size_t n = 0;
+    for (auto const& [id, s] : spools_) n += s.buf.allocated();
+    return n;
+}
+
+void Spool::attach(int job_id, int fd) {
+    auto& s = spools_[job_id];
+    if (s.fd >= 0) ::close(s.fd);
+    s = JobSpool{fd, RingBuffer{job_cap_}, 0};
+}
+
+void Spool::drain() {
+    // drain_job may erase spools, so walk a copy of the open ids.
+    std::vector<int> open;
+    for (auto const& [id, s] : spools_) if (s.fd >= 0) open.push_back(id);
+    for (int id : open) drain_job(id);
+}
+
+bool Spool::drain_job(int job_id, std::string* fresh) {
+    auto it = spools_.find(job_id);
+    if (it == spools_.end()) return false;
+    JobSpool& s = it->second;
+
+    char chunk[4096];
+    while (s.fd >= 0) {
+        ssize_t r = ::read(s.fd, chunk, sizeof(chunk));
+        if (r > 0) {
+            size_t n = static_cast<size_t>(r);
+            s.dropped += s.buf.append(chunk, n);
+            if (fresh) fresh->append(chunk, n);
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // EOF or hard error: the job is done writing.
+        ::close(s.fd);
+        s.fd = -1;
+    }
+
+    const bool open = s.fd >= 0;
+    if (!open && s.buf.size() == 0) spools_.erase(it);
+    enforce_total_cap();
+    return open;
+}
+
+const JobSpool* Spool::find(int job_id) const {
+    auto it = spools_.find(job_id);
+    return it == spools_.end() ? nullptr : &it->second;
+}
+
+void Spool::enforce_total_cap() {
+    // Trim the largest allocation first so one chatty job cannot starve the
+    // rest; finished jobs trimmed to nothing are forgotten.
+    for (size_t used = total(); used > total_cap_; used = total()) {
+        auto biggest = std::max_element(spools_.begin(), spools_.end(),
+            [](auto const& a, auto const& b) { return a.second.buf.allocated() < b.second.buf.allocated(); });
+        if (biggest == spools_.end() || biggest->second.buf.allocated() == 0) break;
+
+        JobSpool& s = biggest->second;
+        const size_t excess = used - total_cap_;
+        const size_t alloc = s.buf.allocated();
+        s.dropped += s.buf.shrink_to(alloc > excess ? alloc - excess : 0);
+        if (s.fd < 0 && s.buf.size() == 0) spools_.erase(biggest);
+    }
+}
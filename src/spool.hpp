@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Fixed-capacity byte ring: appending past capacity drops the oldest bytes.
+// Storage grows lazily up to the capacity so quiet jobs stay cheap.
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t cap = 0) : cap_(cap) {}
+
+    // Returns the number of old bytes that were overwritten.
+    size_t append(const char* data, size_t n);
+
+    // Drops the oldest bytes down to max_bytes and reallocates storage to
+    // fit what is left (freeing it when empty). Returns bytes dropped.
+    size_t shrink_to(size_t max_bytes);
+
+    size_t size() const { return size_; }
+    size_t allocated() const { return buf_.size(); }
+    std::string str() const;
+
+private:
+    size_t pop_front(size_t n);
+    void grow(size_t want);
+
+    size_t cap_{0};
+    size_t head_{0};
+    size_t size_{0};
+    std::vector<char> buf_;
+};
+
+struct JobSpool {
+    int fd{-1};          // non-blocking read end; -1 once the job closed its output
+    RingBuffer buf;
+    size_t dropped{0};   // bytes lost to the per-job or total cap
+};
+
+// Captures stdout/stderr of background jobs into bounded per-job buffers.
+// Filled from the shell's idle loop, never blocks.
+class Spool {
+public:
+    ~Spool();
+
+    bool enabled() const { return enabled_; }
+    void set_enabled(bool on) { enabled_ = on; }
+
+    size_t job_cap() const { return job_cap_; }
+    size_t total_cap() const { return total_cap_; }
+    void set_caps(size_t job_cap, size_t total_cap);
+
+    // Storage currently allocated across all spools; what the total cap bounds.
+    size_t total() const;
+
+    // Takes ownership of fd (must already be non-blocking).
+    void attach(int job_id, int fd);
+
+    // Reads whatever is available on every open spool.
+    void drain();
+
+    // Reads whatever is available for one job, appending new bytes to *fresh.
+    // Returns false once the job's output is closed (or there is no spool).
+    // A closed spool is erased once empty, so find() results don't survive it.
+    bool drain_job(int job_id, std::string* fresh = nullptr);
+
+    const JobSpool* find(int job_id) const;
+
+private:
+    void enforce_total_cap();
+
+    bool enabled_{false};
+    size_t job_cap_{64 * 1024};
+    size_t total_cap_{1024 * 1024};
+    std::map<int, JobSpool> spools_;
+};
+
+Spool& spool();
@@ -17,6 +17,12 @@ void set_cloexec(int fd) {
     if (::fcntl(fd, F_SETFD, flags | FD_CLOEXEC) < 0) throw_errno("fcntl(F_SETFD)");
 }
 
+void set_nonblock(int fd) {
+    int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0) throw_errno("fcntl(F_GETFL)");
+    if (::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) throw_errno("fcntl(F_SETFL)");
+}
+
 int open_read(const std::string& path) {
     int fd = ::open(path.c_str(), O_RDONLY);
     if (fd < 0) throw_errno("open(read)");
@@ -38,4 +44,10 @@ int open_write_append(const std::string& path) {
     return fd;
 }
 
+int open_cwd() {
+    int fd = ::open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw_errno("open(cwd)");
+    return fd;
+}
+
 } // namespace sys
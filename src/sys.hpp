@@ -9,7 +9,9 @@ namespace sys {
 int  open_read(const std::string& path);
 int  open_write_trunc(const std::string& path);
 int  open_write_append(const std::string& path);
+int  open_cwd();   // O_PATH handle on the current directory, for fchdir
 
 void set_cloexec(int fd);
+void set_nonblock(int fd);
 
 } // namespace sys
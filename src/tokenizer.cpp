@@ -1,17 +1,57 @@
 #include "tokenizer.hpp"
+#include "vars.hpp"
 #include <stdexcept>
 
 static bool is_space(char c) { return c==' ' || c=='\t' || c=='\n'; }
 
+static bool is_name_char(char c, bool first) {
+    if (c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) return true;
+    return !first && c >= '0' && c <= '9';
+}
+
+// Expands $NAME, ${NAME} or $? starting at line[i] == '$' into cur.
+// Returns the index of the last character consumed.
+static size_t expand_var(const std::string& line, size_t i, std::string& cur) {
+    if (i + 1 >= line.size()) { cur.push_back('$'); return i; }
+
+    char c = line[i+1];
+    if (c == '?') {
+        cur += std::to_string(vars().last_status());
+        return i + 1;
+    }
+
+    std::string name;
+    size_t end = i + 1;
+    if (c == '{') {
+        end = line.find('}', i + 2);
+        if (end == std::string::npos) throw std::runtime_error("missing }");
+        name = line.substr(i + 2, end - i - 2);
+        if (!is_valid_name(name)) throw std::runtime_error("bad substitution");
+    } else {
+        while (end < line.size() && is_name_char(line[end], end == i + 1)) ++end;
+        if (end == i + 1) { cur.push_back('$'); return i; }  // lone '$'
+        name = line.substr(i + 1, end - i - 1);
+        --end;
+    }
+
+    if (auto v = vars().get(name)) cur += *v;
+    return end;
+}
+
 std::vector<Tok> tokenize(const std::string& line) {
     std::vector<Tok> out;
     std::string cur;
 
+    size_t literal_len = 0;
+    bool literal = true;   // still inside the word's verbatim prefix
+
     auto flush_word = [&](){
         if (!cur.empty()) {
-            out.push_back({TokKind::Word, cur});
+            out.push_back({TokKind::Word, cur, literal_len});
             cur.clear();
         }
+        literal_len = 0;
+        literal = true;
     };
 
     enum class Q { None, Single, Double };
@@ -23,15 +63,24 @@ std::vector<Tok> tokenize(const std::string& line) {
         if (q == Q::None) {
             if (is_space(c)) { flush_word(); continue; }
 
-            if (c == '\'') { q = Q::Single; continue; }
-            if (c == '"')  { q = Q::Double; continue; }
+            if (c == '\'') { q = Q::Single; literal = false; continue; }
+            if (c == '"')  { q = Q::Double; literal = false; continue; }
 
             if (c == '\\') {
+                literal = false;
                 if (i + 1 < line.size()) cur.push_back(line[++i]);
                 else throw std::runtime_error("dangling escape");
                 continue;
             }
 
+            if (c == '$') {
+                size_t last = expand_var(line, i, cur);
+                if (last != i) literal = false;   // a lone '$' stays literal
+                else if (literal) literal_len = cur.size();
+                i = last;
+                continue;
+            }
+
             // operators
             if (c == '|') { flush_word(); out.push_back({TokKind::Pipe, "|"}); continue; }
             if (c == '&') { flush_word(); out.push_back({TokKind::Amp, "&"}); continue; }
@@ -48,11 +97,13 @@ std::vector<Tok> tokenize(const std::string& line) {
             }
 
             cur.push_back(c);
+            if (literal) literal_len = cur.size();
         } else if (q == Q::Single) {
             if (c == '\'') { q = Q::None; continue; }
             cur.push_back(c);
         } else { // double
             if (c == '"') { q = Q::None; continue; }
+            if (c == '$') { i = expand_var(line, i, cur); continue; }
             if (c == '\\') {
                 if (i + 1 < line.size()) cur.push_back(line[++i]);
                 else throw std::runtime_error("dangling escape");
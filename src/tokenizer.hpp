@@ -11,6 +11,9 @@ enum class TokKind {
 struct Tok {
     TokKind kind{};
     std::string text;
+    // Leading chars of text taken verbatim from the input: no quotes, escapes
+    // or $ expansion. Only a NAME= inside this prefix makes an assignment.
+    size_t literal_len{0};
 };
 
 std::vector<Tok> tokenize(const std::string& line);
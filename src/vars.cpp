@@ -0,0 +1,111 @@
+#include "vars.hpp"
+
+#include <algorithm>
+#include <unistd.h>
+
+static Vars g_vars;
+
+Vars& vars() { return g_vars; }
+
+static std::shared_ptr<const Envp> make_envp(std::vector<std::string> entries) {
+    // Fill in place so ptrs never refer to moved-from strings.
+    auto env = std::make_shared<Envp>();
+    env->entries = std::move(entries);
+    env->ptrs.reserve(env->entries.size() + 1);
+    for (auto& e : env->entries) env->ptrs.push_back(e.data());
+    env->ptrs.push_back(nullptr);
+    return env;
+}
+
+bool is_valid_name(const std::string& s) {
+    if (s.empty() || (s[0] >= '0' && s[0] <= '9')) return false;
+    return std::all_of(s.begin(), s.end(), [](char c) {
+        return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    });
+}
+
+bool split_assignment(const std::string& word, Assign& out) {
+    auto pos = word.find('=');
+    if (pos == std::string::npos) return false;
+    std::string name = word.substr(0, pos);
+    if (!is_valid_name(name)) return false;
+    out.name = std::move(name);
+    out.value = word.substr(pos + 1);
+    return true;
+}
+
+Vars::Vars() {
+    for (char** e = environ; e && *e; ++e) {
+        Assign a;
+        if (split_assignment(*e, a)) vars_[a.name] = Var{std::move(a.value), true};
+    }
+}
+
+std::optional<std::string> Vars::get(const std::string& name) const {
+    auto it = vars_.find(name);
+    if (it == vars_.end()) return std::nullopt;
+    return it->second.value;
+}
+
+void Vars::set(const std::string& name, std::string value) {
+    Var& v = vars_[name];
+    v.value = std::move(value);
+    if (v.exported) envp_.reset();
+}
+
+void Vars::set_exported(const std::string& name, std::string value) {
+    Var& v = vars_[name];
+    v.value = std::move(value);
+    v.exported = true;
+    envp_.reset();
+}
+
+bool Vars::export_var(const std::string& name) {
+    auto it = vars_.find(name);
+    if (it == vars_.end()) return false;
+    if (!it->second.exported) {
+        it->second.exported = true;
+        envp_.reset();
+    }
+    return true;
+}
+
+void Vars::unset(const std::string& name) {
+    auto it = vars_.find(name);
+    if (it == vars_.end()) return;
+    if (it->second.exported) envp_.reset();
+    vars_.erase(it);
+}
+
+std::shared_ptr<const Envp> Vars::envp() {
+    if (envp_) return envp_;
+
+    std::vector<std::string> entries;
+    entries.reserve(vars_.size());
+    for (auto const& [name, v] : vars_) {
+        if (v.exported) entries.push_back(name + "=" + v.value);
+    }
+    envp_ = make_envp(std::move(entries));
+    return envp_;
+}
+
+std::shared_ptr<const Envp> Vars::envp_with(const std::vector<Assign>& overrides) {
+    if (overrides.empty()) return envp();
+
+    std::vector<std::string> entries = envp()->entries;
+    for (auto const& a : overrides) {
+        const std::string prefix = a.name + "=";
+        auto it = std::find_if(entries.begin(), entries.end(),
+            [&](const std::string& e) { return e.compare(0, prefix.size(), prefix) == 0; });
+        if (it != entries.end()) *it = prefix + a.value;
+        else entries.push_back(prefix + a.value);
+    }
+    return make_envp(std::move(entries));
+}
+
+std::vector<std::string> Vars::exported_names() const {
+    std::vector<std::string> names;
+    for (auto const& [name, v] : vars_) if (v.exported) names.push_back(name);
+    std::sort(names.begin(), names.end());
+    return names;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "exec.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Immutable, null-terminated environment block handed to exec.
+struct Envp {
+    std::vector<std::string> entries;   // KEY=VALUE
+    std::vector<char*> ptrs;            // points into entries, ends with nullptr
+
+    char** data() const { return const_cast<char**>(ptrs.data()); }
+};
+
+// Shell variables with an exported attribute. Children see only exported
+// ones, through an envp snapshot that is rebuilt only after an exported
+// variable changes; snapshots already handed out stay valid.
+class Vars {
+public:
+    Vars();  // imports environ, all exported
+
+    std::optional<std::string> get(const std::string& name) const;
+
+    // Keeps the variable's exported attribute (new variables are local).
+    void set(const std::string& name, std::string value);
+    void set_exported(const std::string& name, std::string value);
+    bool export_var(const std::string& name);   // false if not set
+    void unset(const std::string& name);
+
+    int last_status() const { return last_status_; }
+    void set_last_status(int s) { last_status_ = s; }
+
+    std::shared_ptr<const Envp> envp();
+    // Snapshot plus per-command VAR=val overrides.
+    std::shared_ptr<const Envp> envp_with(const std::vector<Assign>& overrides);
+
+    std::vector<std::string> exported_names() const;
+
+private:
+    struct Var {
+        std::string value;
+        bool exported{false};
+    };
+
+    std::unordered_map<std::string, Var> vars_;
+    std::shared_ptr<const Envp> envp_;  // null when stale
+    int last_status_{0};
+};
+
+bool is_valid_name(const std::string& s);
+
+// Splits NAME=VALUE; false if word is not an assignment.
+bool split_assignment(const std::string& word, Assign& out);
+
+Vars& vars();